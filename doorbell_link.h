@@ -0,0 +1,136 @@
+/**
+ * ESP32 Remote Deurbel - RING/QSL protocol
+ * ============================================
+ *
+ * Protocollogica die zender en ontvanger delen, eenmalig geschreven
+ * tegen de DoorbellTransport-interface (zie doorbell_transport.h).
+ *
+ * - Zender:    sendRing() verstuurt "RING" en start het wachten op "QSL";
+ *              poll() verstuurt de herhalingen tot QSL binnen is
+ * - Ontvanger: poll() meldt DOORBELL_RING en stuurt direct "QSL" terug
+ * - Zender:    poll() meldt DOORBELL_ACK of, na de timeout, DOORBELL_ACK_TIMEOUT
+ *
+ * Herhaalde RINGs binnen duplicateWindow en QSLs waar niet op gewacht wordt
+ * (dubbel of na de timeout) worden als DOORBELL_NONE gemeld.
+ *
+ * Tijden worden door de aanroeper meegegeven (millis()), zodat de logica
+ * ook buiten de ESP32 gebruikt kan worden.
+ *
+ * Auteur: MiniMax Agent
+ * Datum: Januari 2026
+ */
+
+#ifndef DOORBELL_LINK_H
+#define DOORBELL_LINK_H
+
+#include "doorbell_transport.h"
+
+const char* const DOORBELL_RING_PAYLOAD = "RING";          // Signaal payload
+const char* const DOORBELL_ACK_PAYLOAD = "QSL";            // Bevestiging payload
+
+const unsigned long DOORBELL_RING_INTERVAL = 50;          // Tijd tussen RING herhalingen (ms)
+const unsigned long DOORBELL_DUPLICATE_WINDOW = 1000;     // RING binnen deze tijd is een herhaling (ms)
+
+enum DoorbellEvent {
+    DOORBELL_NONE,                                        // Niets gebeurd
+    DOORBELL_RING,                                        // RING ontvangen (QSL is al verstuurd)
+    DOORBELL_ACK,                                         // QSL ontvangen
+    DOORBELL_ACK_TIMEOUT,                                 // Geen QSL binnen de timeout
+    DOORBELL_UNKNOWN                                      // Onbekend frame ontvangen
+};
+
+class DoorbellLink {
+public:
+    // Alle tijden in dezelfde eenheid als de 'now' die de aanroeper meegeeft
+    DoorbellLink(DoorbellTransport& transport, unsigned long ackTimeout,
+                 unsigned long ringInterval = DOORBELL_RING_INTERVAL,
+                 unsigned long duplicateWindow = DOORBELL_DUPLICATE_WINDOW)
+        : transport(transport), ackTimeout(ackTimeout), ringInterval(ringInterval),
+          duplicateWindow(duplicateWindow) {}
+
+    bool begin() { return transport.begin(); }
+
+    bool linkUp() { return transport.linkUp(); }
+
+    const char* transportName() const { return transport.name(); }
+
+    // Verstuur RING en start de ACK-wachttijd. Verbindingsloze transports
+    // herhalen RING vanuit poll() elke ringInterval, tot QSL binnen is.
+    bool sendRing(unsigned long now) {
+        waiting = true;
+        ackWaitStartTime = now;
+        lastRingTime = now;
+        ringsLeft = transport.redundancy() - 1;
+        return transport.sendFrame(DOORBELL_RING_PAYLOAD);
+    }
+
+    // Non-blocking: verwerk hoogstens één ontvangen frame, verstuur openstaande
+    // RING herhalingen en bewaak de ACK-timeout
+    DoorbellEvent poll(unsigned long now) {
+        if (waiting && ringsLeft > 0 && now - lastRingTime >= ringInterval) {
+            transport.sendFrame(DOORBELL_RING_PAYLOAD);
+            lastRingTime = now;
+            ringsLeft--;
+        }
+
+        size_t len = transport.pollFrame(frame, sizeof(frame));
+        if (len > 0) {
+            if (strcmp(frame, DOORBELL_RING_PAYLOAD) == 0) {
+                // Ook een herhaling krijgt QSL: de zender herhaalt alleen zolang
+                // hij nog geen QSL heeft, dus de vorige is mogelijk verloren gegaan
+                transport.sendFrame(DOORBELL_ACK_PAYLOAD);
+
+                bool repeat = ringSeen && (now - lastRingRxTime < duplicateWindow);
+                ringSeen = true;
+                lastRingRxTime = now;
+                return repeat ? DOORBELL_NONE : DOORBELL_RING;
+            }
+            if (strcmp(frame, DOORBELL_ACK_PAYLOAD) == 0) {
+                if (!waiting) return DOORBELL_NONE;       // Dubbele of te late QSL
+
+                ackLatency = now - ackWaitStartTime;
+                waiting = false;
+                ringsLeft = 0;                            // Herhalingen zijn niet meer nodig
+                return DOORBELL_ACK;
+            }
+            return DOORBELL_UNKNOWN;
+        }
+
+        if (waiting && (now - ackWaitStartTime > ackTimeout)) {
+            waiting = false;
+            ringsLeft = 0;
+            return DOORBELL_ACK_TIMEOUT;
+        }
+        return DOORBELL_NONE;
+    }
+
+    // Stop met wachten op QSL (bijv. bij verbindingsverlies)
+    void cancelAck() {
+        waiting = false;
+        ringsLeft = 0;
+    }
+
+    bool waitingForAck() const { return waiting; }
+
+    // Tijd van eerste RING tot QSL bij de laatste geslaagde bevestiging
+    unsigned long lastAckLatency() const { return ackLatency; }
+
+    // Laatst ontvangen frame, voor logging
+    const char* lastFrame() const { return frame; }
+
+private:
+    DoorbellTransport& transport;
+    unsigned long ackTimeout;
+    unsigned long ringInterval;
+    unsigned long duplicateWindow;
+    bool ringSeen = false;
+    unsigned long lastRingRxTime = 0;
+    bool waiting = false;
+    unsigned long ackWaitStartTime = 0;
+    unsigned long lastRingTime = 0;
+    int ringsLeft = 0;
+    unsigned long ackLatency = 0;
+    char frame[DOORBELL_MAX_FRAME] = {0};
+};
+
+#endif // DOORBELL_LINK_H
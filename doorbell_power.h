@@ -0,0 +1,458 @@
+/**
+ * ESP32 Remote Deurbel - WiFi energieprofielen
+ * ============================================
+ *
+ * Expliciete keuze tussen reactietijd en stroomverbruik, in plaats van
+ * het standaard modem-sleep/DTIM gedrag van de WiFi-stack.
+ *
+ * Profielen:
+ * - POWER_LOW_LATENCY: geen power save, radio altijd aan (ontvanger op netvoeding)
+ * - POWER_BALANCED:    modem sleep, radio wordt wakker per listen interval
+ * - POWER_BATTERY:     modem sleep + light sleep tussen de loop-rondes,
+ *                      wakker worden via de drukknop op GPIO 13 (zender op batterij).
+ *                      Zonder wake-pin (ontvanger) wordt dit balanced: niets
+ *                      zou de unit wekken voor een binnenkomende RING.
+ *
+ * Light sleep in het battery-profiel:
+ * - Automatisch (esp_pm_configure) als de ESP32-core met CONFIG_PM_ENABLE en
+ *   CONFIG_FREERTOS_USE_TICKLESS_IDLE is gebouwd. De WiFi-stack houdt de
+ *   verbinding dan zelf in stand; idle() geeft alleen de CPU vrij met delay().
+ *   De CPU-frequentie blijft vast, zodat de geslapen tijd uit het verschil
+ *   tussen systeemtimer en cycle counter (staat stil in light sleep) volgt.
+ * - Anders handmatig (esp_light_sleep_start). Omdat ESP-IDF de WiFi-verbinding
+ *   niet over een handmatige light sleep in stand houdt, wordt WiFi vooraf
+ *   gestopt en na het wakker worden opnieuw gestart en verbonden. De zender
+ *   slaapt dan tot de knop wordt ingedrukt; er is geen timer-wake, want elke
+ *   wake kost een herverbinding.
+ *
+ * Het profiel wordt bij het compileren gekozen met DOORBELL_POWER_PROFILE
+ * en kan tijdens gebruik gewisseld worden via de seriële monitor:
+ *   '1' = low-latency, '2' = balanced, '3' = battery, 'p' = rapport tonen
+ * In light sleep staat de UART stil. Een teken op de seriële poort wekt de
+ * unit dan (dat teken gaat verloren), waarna hij POWER_SERIAL_WINDOW wakker
+ * blijft voor commando's, zonder dat de deurbel hoeft te gaan.
+ *
+ * Het rapport van de zender toont twee gemeten latenties:
+ * - wake-naar-TX: eerste LOW-lezing van de knop of GPIO-wake tot verzenden van
+ *   RING, inclusief debounce en herverbinden (profiel zender)
+ * - RING-naar-QSL: tijdens deze uitwisseling houdt de zender zijn radio wakker,
+ *   dus de tijd wordt bepaald door de RX-latentie van de ontvanger (zijn profiel)
+ * Daarnaast een geschat gemiddeld stroomverbruik. De schatting
+ * gebruikt nominale waarden per toestand met de gemeten tijd in light sleep
+ * en de tijd dat de radio volledig actief is (herverbinden, wachten op QSL);
+ * voor een echte meting is een stroommeter in de voeding nodig.
+ *
+ * Auteur: MiniMax Agent
+ * Datum: Januari 2026
+ */
+
+#ifndef DOORBELL_POWER_H
+#define DOORBELL_POWER_H
+
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <esp_sleep.h>
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#define POWER_AUTO_LIGHT_SLEEP 1
+#else
+#define POWER_AUTO_LIGHT_SLEEP 0
+#endif
+
+// ============================================
+// PROFIELKEUZE
+// ============================================
+
+#define POWER_LOW_LATENCY  1
+#define POWER_BALANCED     2
+#define POWER_BATTERY      3
+
+#ifndef DOORBELL_POWER_PROFILE
+#define DOORBELL_POWER_PROFILE POWER_LOW_LATENCY
+#endif
+
+// Listen interval in beacons (ca. 102 ms per beacon) voor modem sleep; de
+// ESP-IDF standaard is 3 (ca. 300 ms). Het access point bewaart frames voor een
+// slapende ESP32 tot de volgende listen interval, dus dit is de extra RX-latentie.
+// - balanced: 1 (ca. 100 ms), een RING/QSL blijft ruim onder de waarneembare
+//   vertraging van een deurbel, terwijl de radio tussen de beacons uit is
+// - battery:  10 (ca. 1 s), alleen van belang bij automatische light sleep:
+//   tussen twee drukken blijft WiFi verbonden en wordt de radio per listen
+//   interval wakker voor een beacon, dus minder beacons = minder wake-ups.
+//   QSL merkt hier niets van (recordTx() zet power save uit tijdens de
+//   uitwisseling); bij handmatige light sleep staat WiFi tussen drukken uit.
+const uint16_t POWER_LISTEN_INTERVAL_BALANCED = 1;
+const uint16_t POWER_LISTEN_INTERVAL_BATTERY = 10;
+
+// Automatische light sleep: zo lang geeft idle() de CPU vrij per loop-ronde (ms)
+const unsigned long POWER_IDLE_DELAY = 20;
+
+// Wake via de seriële poort: aantal stijgende flanken op RX (een Enter is genoeg)
+// en hoe lang de unit daarna wakker blijft voor commando's (ms)
+const int POWER_UART_WAKE_THRESHOLD = 3;
+const unsigned long POWER_SERIAL_WINDOW = 15000;
+
+// Maximale wachttijd op herverbinding na een handmatige light sleep (ms)
+const unsigned long POWER_RECONNECT_TIMEOUT = 5000;
+
+// Interval voor het periodieke energierapport (ms)
+const unsigned long POWER_REPORT_INTERVAL = 300000;
+
+// Nominaal stroomverbruik per toestand (mA), schattingen voor ESP32 op 240 MHz
+const float POWER_ACTIVE_MA = 95.0;                       // WiFi verbonden, geen power save (80-100 mA)
+const float POWER_MODEM_SLEEP_MA = 30.0;                  // Radio uit tussen beacons
+const float POWER_LIGHT_SLEEP_MA = 0.8;                   // CPU en radio gepauzeerd
+
+// Resultaat van idle()
+enum PowerWake {
+    POWER_NO_SLEEP,                                       // Niet geslapen
+    POWER_WAKE_TIMER,                                     // Automatisch geslapen, na POWER_IDLE_DELAY
+    POWER_WAKE_BUTTON,                                    // Geslapen, gewekt door de drukknop
+    POWER_WAKE_SERIAL                                     // Geslapen, gewekt via de seriële poort
+};
+
+class PowerManager {
+public:
+    // wakePin: drukknop (LOW = ingedrukt) om uit light sleep te komen, of -1 voor geen
+    explicit PowerManager(int wakePin) : wakePin(wakePin) {}
+
+    // Profiel instellen; aanroepen na WiFi.begin() en opnieuw bij elke wissel
+    void apply(int newProfile) {
+        if (newProfile == POWER_BATTERY && wakePin < 0) {
+            Serial.println("Battery-profiel vereist een wake-knop; zonder wordt RING gemist.");
+            Serial.println("  Balanced (alleen modem sleep) wordt gebruikt.");
+            newProfile = POWER_BALANCED;
+        }
+        profile = newProfile;
+
+        if (profile == POWER_LOW_LATENCY) {
+            esp_wifi_set_ps(WIFI_PS_NONE);
+        } else {
+            setListenInterval(profile == POWER_BATTERY ? POWER_LISTEN_INTERVAL_BATTERY
+                                                       : POWER_LISTEN_INTERVAL_BALANCED);
+            esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+        }
+        configureLightSleep(profile == POWER_BATTERY);
+
+        radioHeld = false;
+
+        // Statistieken gelden per profiel
+        wakeToTx.reset();
+        ringToAckStats.reset();
+        statsStartTime = millis();
+        lightSleepUs = 0;
+        activeTime = 0;
+
+        Serial.print("Energieprofiel: ");
+        Serial.println(profileName());
+        if (profile == POWER_BATTERY) {
+            Serial.println(POWER_AUTO_LIGHT_SLEEP ? "  Light sleep: automatisch (WiFi blijft verbonden)"
+                                                  : "  Light sleep: handmatig (WiFi uit tijdens slaap)");
+        }
+    }
+
+    int currentProfile() const { return profile; }
+
+    const char* profileName() const {
+        switch (profile) {
+            case POWER_LOW_LATENCY: return "low-latency (geen power save)";
+            case POWER_BALANCED:    return "balanced (modem sleep)";
+            case POWER_BATTERY:     return "battery (light sleep, wake op GPIO)";
+            default:                return "onbekend";
+        }
+    }
+
+    // Aanroepen aan het eind van loop(); slaapt alleen in het battery-profiel
+    // en alleen als de sketch aangeeft dat er niets loopt (geen ACK, geen LED-timer).
+    // Bij POWER_WAKE_BUTTON is de knopdruk mogelijk al voorbij: de sketch moet
+    // die zelf als druk verwerken.
+    PowerWake idle(bool mayLightSleep) {
+        radioRestarted = false;
+        if (profile != POWER_BATTERY || !mayLightSleep || wakePin < 0) return POWER_NO_SLEEP;
+        if (digitalRead(wakePin) == LOW) return POWER_NO_SLEEP;                    // Knop ingedrukt
+        if (serialAwake) {                                // Wakker blijven voor commando's
+            if (millis() - serialAwakeSince < POWER_SERIAL_WINDOW) return POWER_NO_SLEEP;
+            serialAwake = false;
+        }
+
+#if POWER_AUTO_LIGHT_SLEEP
+        // FreeRTOS idle-task gaat zelf in light sleep; WiFi blijft verbonden.
+        // Niet elke delay() wordt slaap: alleen het deel waarin de cycle counter
+        // stilstond terwijl de systeemtimer doorliep telt mee.
+        int64_t wallStart = esp_timer_get_time();
+        uint32_t cyclesStart = ESP.getCycleCount();
+        delay(POWER_IDLE_DELAY);
+        int64_t wallUs = esp_timer_get_time() - wallStart;
+        int64_t awakeUs = (uint32_t)(ESP.getCycleCount() - cyclesStart) / getCpuFrequencyMhz();
+        int64_t sleptUs = wallUs - awakeUs;
+        if (sleptUs > 0) lightSleepUs += sleptUs;
+
+        // Wakker geworden door een teken op de seriële poort (niet door een oude wake)
+        if (sleptUs > 1000 && esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UART) {
+            startSerialWindow();
+            return POWER_WAKE_SERIAL;
+        }
+        return POWER_WAKE_TIMER;
+#else
+        // WiFi blijft niet verbonden tijdens handmatige light sleep: netjes stoppen
+        bool wasConnected = WiFi.status() == WL_CONNECTED;
+        esp_wifi_stop();
+
+        Serial.flush();                                   // UART stopt tijdens light sleep
+        int64_t sleepStart = esp_timer_get_time();
+        bool slept = esp_light_sleep_start() == ESP_OK;
+        if (slept) lightSleepUs += esp_timer_get_time() - sleepStart;
+
+        PowerWake wake = POWER_NO_SLEEP;
+        esp_sleep_wakeup_cause_t cause = slept ? esp_sleep_get_wakeup_cause() : ESP_SLEEP_WAKEUP_UNDEFINED;
+        if (cause == ESP_SLEEP_WAKEUP_GPIO) {
+            pressTime = millis();                         // Vóór het herverbinden: telt mee
+            pressPending = true;
+            wake = POWER_WAKE_BUTTON;
+        } else if (cause == ESP_SLEEP_WAKEUP_UART) {
+            wake = POWER_WAKE_SERIAL;
+        }
+
+        // WiFi weer starten en, als er een router was, wachten op herverbinding;
+        // de radio is daarbij volledig actief
+        unsigned long reconnectStart = millis();
+        esp_wifi_start();
+        if (wasConnected) {
+            esp_wifi_connect();
+            while (WiFi.status() != WL_CONNECTED && millis() - reconnectStart < POWER_RECONNECT_TIMEOUT) {
+                delay(10);
+            }
+        }
+        activeTime += millis() - reconnectStart;
+        radioRestarted = true;
+        if (wake == POWER_WAKE_SERIAL) startSerialWindow();
+        return wake;
+#endif
+    }
+
+    // Is WiFi in de laatste idle() gestopt en opnieuw gestart? Dan moet het
+    // transport opnieuw gestart worden (socket, ESP-NOW).
+    bool radioWasRestarted() const { return radioRestarted; }
+
+    // Eerste LOW-lezing van de knop, vóór de debounce: begin van de wake-naar-TX
+    // meting. Dender en een GPIO-wake die al loopt veranderen het begin niet.
+    void markPress(unsigned long now) {
+        if (pressPending) return;
+        pressTime = now;
+        pressPending = true;
+    }
+
+    // Knop losgelaten zonder verzending (dender, anti-spam): meting vervalt
+    void clearPress() { pressPending = false; }
+
+    // RING is verstuurd: wake-naar-TX vastleggen (kosten van het eigen profiel)
+    // en de radio wakker houden tot QSL binnen is, zodat de RING-naar-QSL tijd
+    // alleen door het profiel van de ontvanger wordt bepaald
+    void recordTx(unsigned long now) {
+        if (pressPending) wakeToTx.add(now - pressTime);
+        pressPending = false;
+        if (profile != POWER_LOW_LATENCY) {
+            esp_wifi_set_ps(WIFI_PS_NONE);
+            radioHeld = true;
+            radioHeldSince = now;
+        }
+    }
+
+    // QSL ontvangen na ringToAck (ms)
+    void recordAck(unsigned long ringToAck) {
+        ringToAckStats.add(ringToAck);
+        releaseRadio();
+    }
+
+    // Uitwisseling voorbij (timeout, verbindingsverlies): power save terugzetten
+    void releaseRadio() {
+        if (!radioHeld) return;
+        radioHeld = false;
+        activeTime += millis() - radioHeldSince;
+        esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+    }
+
+    // Geschat gemiddeld stroomverbruik sinds de laatste profielwissel: gemeten
+    // light sleep en actieve tijd, de rest tegen het verbruik van het profiel
+    float estimatedCurrent() const {
+        unsigned long total = millis() - statsStartTime;
+        float awakeMa = (profile == POWER_LOW_LATENCY) ? POWER_ACTIVE_MA : POWER_MODEM_SLEEP_MA;
+        if (total == 0) return awakeMa;
+
+        float sleepMs = lightSleepUs / 1000.0;
+        float restMs = total - sleepMs - activeTime;
+        if (restMs < 0) restMs = 0;
+        return (POWER_LIGHT_SLEEP_MA * sleepMs + POWER_ACTIVE_MA * activeTime + awakeMa * restMs) / total;
+    }
+
+    void printReport() {
+        unsigned long total = millis() - statsStartTime;
+
+        Serial.println("---------- Energierapport ----------");
+        Serial.print("  Profiel: ");
+        Serial.println(profileName());
+        Serial.print("  Meetduur: ");
+        Serial.print(total / 1000);
+        Serial.println(" s");
+        Serial.print("  Light sleep (gemeten): ");
+        Serial.print(total ? (lightSleepUs / 10.0 / total) : 0.0, 1);
+        Serial.println(" %");
+        Serial.print("  Actief (herverbinden, wachten op QSL): ");
+        Serial.print(total ? (100.0 * activeTime / total) : 0.0, 1);
+        Serial.println(" %");
+        Serial.print("  Geschat gemiddeld verbruik: ");
+        Serial.print(estimatedCurrent(), 1);
+        Serial.println(" mA");
+        if (wakePin >= 0) {
+            wakeToTx.print("  Wake-naar-TX (dit profiel): ");
+            ringToAckStats.print("  RING-naar-QSL (profiel ontvanger): ");
+        } else {
+            // De ontvanger kent het verzendmoment van RING niet; zijn RX-latentie
+            // is de RING-naar-QSL tijd in het rapport van de zender
+            Serial.println("  RX-latentie van dit profiel: zie RING-naar-QSL op de zender");
+        }
+        Serial.println("------------------------------------");
+    }
+
+    // Seriële commando's voor profielwissel en rapport; periodiek rapport
+    void update() {
+        while (Serial.available()) {
+            if (serialAwake) serialAwakeSince = millis(); // Venster loopt door tijdens typen
+            switch (Serial.read()) {
+                case '1': apply(POWER_LOW_LATENCY); break;
+                case '2': apply(POWER_BALANCED); break;
+                case '3': apply(POWER_BATTERY); break;
+                case 'p': printReport(); break;
+                default: break;
+            }
+        }
+
+        if (millis() - lastReportTime > POWER_REPORT_INTERVAL) {
+            lastReportTime = millis();
+            printReport();
+        }
+    }
+
+private:
+    int wakePin;
+    int profile = POWER_LOW_LATENCY;
+
+    unsigned long pressTime = 0;
+    bool pressPending = false;
+
+    struct LatencyStats {
+        unsigned long samples = 0;
+        unsigned long sum = 0;
+        unsigned long min = 0;
+        unsigned long max = 0;
+
+        void add(unsigned long latency) {
+            if (samples == 0 || latency < min) min = latency;
+            if (latency > max) max = latency;
+            sum += latency;
+            samples++;
+        }
+
+        void reset() {
+            samples = 0;
+            sum = 0;
+            min = 0;
+            max = 0;
+        }
+
+        void print(const char* label) const {
+            Serial.print(label);
+            if (samples == 0) {
+                Serial.println("nog geen metingen");
+                return;
+            }
+            Serial.print("min ");
+            Serial.print(min);
+            Serial.print(" / gem ");
+            Serial.print(sum / samples);
+            Serial.print(" / max ");
+            Serial.print(max);
+            Serial.print(" ms (");
+            Serial.print(samples);
+            Serial.println(" metingen)");
+        }
+    };
+
+    LatencyStats wakeToTx;
+    LatencyStats ringToAckStats;
+    bool radioHeld = false;
+    unsigned long radioHeldSince = 0;
+
+    unsigned long statsStartTime = 0;
+    uint64_t lightSleepUs = 0;                            // Gemeten tijd in light sleep
+    unsigned long activeTime = 0;                         // Radio volledig actief (ms)
+    unsigned long lastReportTime = 0;
+    bool radioRestarted = false;
+    bool serialAwake = false;
+    unsigned long serialAwakeSince = 0;
+
+    // Na een wake via de seriële poort wakker blijven zodat commando's aankomen
+    void startSerialWindow() {
+        serialAwake = true;
+        serialAwakeSince = millis();
+        Serial.print("Wakker via seriële poort: commando's (1, 2, 3, p) ");
+        Serial.print(POWER_SERIAL_WINDOW / 1000);
+        Serial.println(" s mogelijk");
+    }
+
+    // Drukknop en seriële poort als wake-bron en, indien beschikbaar,
+    // automatische light sleep
+    void configureLightSleep(bool enable) {
+        if (enable && wakePin >= 0) {
+            gpio_wakeup_enable((gpio_num_t)wakePin, GPIO_INTR_LOW_LEVEL);
+            esp_sleep_enable_gpio_wakeup();
+            uart_set_wakeup_threshold(UART_NUM_0, POWER_UART_WAKE_THRESHOLD);
+            esp_sleep_enable_uart_wakeup(UART_NUM_0);
+        }
+
+#if POWER_AUTO_LIGHT_SLEEP
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+        esp_pm_config_t pmConfig = {};
+#else
+        esp_pm_config_esp32_t pmConfig = {};
+#endif
+        // Geen frequentieschaling: de slaapmeting in idle() (en de profiler)
+        // rekent cycles om met de vaste CPU-frequentie
+        pmConfig.max_freq_mhz = getCpuFrequencyMhz();
+        pmConfig.min_freq_mhz = getCpuFrequencyMhz();
+        pmConfig.light_sleep_enable = enable;
+        if (esp_pm_configure(&pmConfig) != ESP_OK) {
+            Serial.println("WAARSCHUWING: automatische light sleep niet beschikbaar");
+        }
+#endif
+    }
+
+    // Het listen interval wordt bij het verbinden met het access point afgesproken;
+    // bij een wijziging tijdens een verbinding wordt daarom opnieuw verbonden
+    void setListenInterval(uint16_t interval) {
+        wifi_config_t conf;
+        if (esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK) return;
+        if (conf.sta.listen_interval == interval) return;
+        conf.sta.listen_interval = interval;
+        if (esp_wifi_set_config(WIFI_IF_STA, &conf) != ESP_OK) return;
+
+        if (WiFi.status() == WL_CONNECTED) {
+            Serial.print("Listen interval ");
+            Serial.print(interval);
+            Serial.println(": opnieuw verbinden met router...");
+            WiFi.reconnect();
+            delay(100);                                   // Verbinding eerst laten vallen
+            unsigned long reconnectStart = millis();
+            while (WiFi.status() != WL_CONNECTED && millis() - reconnectStart < POWER_RECONNECT_TIMEOUT) {
+                delay(10);
+            }
+        }
+    }
+};
+
+#endif // DOORBELL_POWER_H
@@ -0,0 +1,370 @@
+/**
+ * ESP32 Remote Deurbel - Hot-path profiler
+ * ============================================
+ *
+ * Meet hoeveel tijd de onderdelen van loop() kosten, zodat aangetoond kan
+ * worden dat een wijziging het RING-naar-toon pad echt korter maakt.
+ *
+ * Gebruik:
+ *   PROFILE_LOOP();            // Bovenaan loop(): meet de loop-periode
+ *   PROFILE_REPORT();          // In loop(): periodiek overzicht op Serial
+ *   PROFILE_ZONE("naam");      // Meet de rest van het huidige blok (cycles)
+ *   PROFILE_ZONE_WALL("naam"); // Idem met de wandklok, voor blokken die slapen
+ *   PROFILE_SPAN(var, "naam"); // Globaal: pad dat over functies heen loopt
+ *   PROFILE_SPAN_BEGIN(var);   // Begin van het pad (een vorig begin vervalt)
+ *   PROFILE_SPAN_END(var);     // Einde van het pad: duur vastleggen (cycles)
+ *
+ * Per zone worden aantal aanroepen en min/gem/max bijgehouden, voor de
+ * loop-periode ook een histogram en het aantal stalls. Na elk overzicht
+ * beginnen de tellers opnieuw.
+ *
+ * Op de ESP32 meten zones met ESP.getCycleCount() (één register-read),
+ * op de PC met rdtsc of std::chrono::steady_clock. De cycle counter staat
+ * stil tijdens light sleep; daarom gebruiken de loop-periode en
+ * PROFILE_ZONE_WALL de wandklok esp_timer_get_time(), die doorloopt
+ * tijdens slaap. Cycles worden omgerekend met de huidige CPU-frequentie;
+ * staat frequentieschaling (DFS) aan, dan klopt dat niet en worden de
+ * cycle-zones in het overzicht als ongeldig gemeld.
+ *
+ * Zonder DOORBELL_PROFILING zijn alle macro's leeg en wordt er niets
+ * meegecompileerd.
+ *
+ * Auteur: MiniMax Agent
+ * Datum: Januari 2026
+ */
+
+#ifndef DOORBELL_PROFILER_H
+#define DOORBELL_PROFILER_H
+
+#ifdef DOORBELL_PROFILING
+
+#include <stdint.h>
+
+// ============================================
+// INSTELLINGEN
+// ============================================
+
+#ifndef DOORBELL_PROFILE_INTERVAL
+#define DOORBELL_PROFILE_INTERVAL 10000                   // Overzicht elke 10 seconden (ms)
+#endif
+
+const int PROFILE_MAX_ZONES = 12;                         // Laatste zone vangt de rest op
+const uint32_t PROFILE_STALL_US = 10000;                  // Loop-periode vanaf 10 ms telt als stall
+
+// Bovengrenzen van de histogram-bakjes voor de loop-periode (us)
+const uint32_t PROFILE_BUCKETS_US[] = {50, 100, 250, 500, 1000, 5000, 20000, 100000};
+const int PROFILE_BUCKET_COUNT = sizeof(PROFILE_BUCKETS_US) / sizeof(PROFILE_BUCKETS_US[0]) + 1;
+
+// ============================================
+// KLOKBRON
+// ============================================
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#ifdef CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+typedef uint32_t ProfileTicks;                            // Cycle counter, loopt na ~18 s over (240 MHz)
+
+inline ProfileTicks profileNow() { return ESP.getCycleCount(); }
+inline uint32_t profileTicksPerUs() { return getCpuFrequencyMhz(); }
+inline unsigned long profileMillis() { return millis(); }
+inline uint64_t profileWallUs() { return esp_timer_get_time(); }   // Loopt door in light sleep
+
+// Cycles zijn alleen naar us om te rekenen als de CPU-frequentie vast staat
+inline bool profileCyclesValid() {
+#ifdef CONFIG_PM_ENABLE
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    esp_pm_config_t pmConfig;
+#else
+    esp_pm_config_esp32_t pmConfig;
+#endif
+    if (esp_pm_get_configuration(&pmConfig) == ESP_OK &&
+        pmConfig.min_freq_mhz != pmConfig.max_freq_mhz) {
+        return false;                                     // DFS: 40-240 MHz, tot 6x ernaast
+    }
+#endif
+    return true;
+}
+
+#define PROFILE_PRINTF(...) Serial.printf(__VA_ARGS__)
+
+#else
+
+#include <stdio.h>
+#include <chrono>
+
+inline uint64_t profileSteadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline unsigned long profileMillis() { return profileSteadyNs() / 1000000; }
+inline uint64_t profileWallUs() { return profileSteadyNs() / 1000; }
+inline bool profileCyclesValid() { return true; }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <x86intrin.h>
+
+typedef uint64_t ProfileTicks;
+
+inline ProfileTicks profileNow() { return __rdtsc(); }
+
+// TSC-frequentie eenmalig bepalen tegen steady_clock (10 ms)
+inline uint32_t profileTicksPerUs() {
+    static uint32_t ticksPerUs = 0;
+    if (ticksPerUs == 0) {
+        uint64_t startNs = profileSteadyNs();
+        ProfileTicks startTicks = profileNow();
+        while (profileSteadyNs() - startNs < 10000000) {}
+        uint64_t elapsedUs = (profileSteadyNs() - startNs) / 1000;
+        ticksPerUs = (uint32_t)((profileNow() - startTicks) / elapsedUs);
+        if (ticksPerUs == 0) ticksPerUs = 1;
+    }
+    return ticksPerUs;
+}
+
+#else
+
+typedef uint64_t ProfileTicks;
+
+inline ProfileTicks profileNow() { return profileSteadyNs(); }
+inline uint32_t profileTicksPerUs() { return 1000; }
+
+#endif
+
+#define PROFILE_PRINTF(...) printf(__VA_ARGS__)
+
+#endif // ARDUINO
+
+// ============================================
+// STATISTIEKEN
+// ============================================
+
+// Een zone telt in cycles (profileNow) of, met wallClock, in us (profileWallUs)
+struct ProfileZone {
+    const char* name;
+    bool wallClock;
+    uint32_t calls;
+    uint64_t totalTicks;
+    uint64_t minTicks;
+    uint64_t maxTicks;
+
+    void add(uint64_t ticks) {
+        if (calls == 0 || ticks < minTicks) minTicks = ticks;
+        if (ticks > maxTicks) maxTicks = ticks;
+        totalTicks += ticks;
+        calls++;
+    }
+
+    void reset() {
+        calls = 0;
+        totalTicks = 0;
+        minTicks = 0;
+        maxTicks = 0;
+    }
+};
+
+class Profiler {
+public:
+    // Zone opzoeken of registreren; eenmalig per PROFILE_ZONE via een static
+    static ProfileZone* zone(const char* name, bool wallClock) {
+        State& s = state();
+        if (s.zoneCount < PROFILE_MAX_ZONES - 1) {
+            ProfileZone* z = &s.zones[s.zoneCount++];
+            z->name = name;
+            z->wallClock = wallClock;
+            return z;
+        }
+        ProfileZone* overflow = &s.zones[PROFILE_MAX_ZONES - 1];
+        overflow->name = "(overig)";
+        s.zoneCount = PROFILE_MAX_ZONES;
+        return overflow;
+    }
+
+    // Begin van een loop-ronde: periode sinds de vorige ronde vastleggen,
+    // met de wandklok zodat tijd in light sleep meetelt
+    static void loopTick() {
+        State& s = state();
+        uint64_t now = profileWallUs();
+        if (s.loopStarted) {
+            uint64_t periodUs = now - s.lastLoop;
+            s.loop.wallClock = true;
+            s.loop.add(periodUs);
+
+            int bucket = 0;
+            while (bucket < PROFILE_BUCKET_COUNT - 1 && periodUs >= PROFILE_BUCKETS_US[bucket]) {
+                bucket++;
+            }
+            s.histogram[bucket]++;
+            if (periodUs >= PROFILE_STALL_US) s.stalls++;
+        }
+        s.lastLoop = now;
+        s.loopStarted = true;
+    }
+
+    // Periodiek overzicht tonen en tellers resetten
+    static void report() {
+        State& s = state();
+        unsigned long nowMs = profileMillis();
+        if (!s.reportStarted) {                           // Eerste meetperiode begint nu
+            s.reportStarted = true;
+            s.lastReport = nowMs;
+            s.cyclesValid = profileCyclesValid();
+            return;
+        }
+        if (nowMs - s.lastReport < DOORBELL_PROFILE_INTERVAL) return;
+
+        // Geldig als de frequentie aan begin en eind van de periode vast stond
+        uint32_t perUs = (s.cyclesValid && profileCyclesValid()) ? profileTicksPerUs() : 0;
+
+        PROFILE_PRINTF("---------- Profiel (%lu ms, %lu loops) ----------\n",
+                       nowMs - s.lastReport, (unsigned long)s.loop.calls);
+        PROFILE_PRINTF("  %-24s %8s %10s %10s %10s\n", "zone", "calls", "min us", "gem us", "max us");
+        for (int i = 0; i < s.zoneCount; i++) {
+            printZone(s.zones[i], s.zones[i].name, perUs);
+        }
+        printZone(s.loop, "loop-periode", perUs);
+        PROFILE_PRINTF("  (*) wandklok, inclusief light sleep\n");
+        if (perUs == 0) {
+            PROFILE_PRINTF("  Cycle-zones ongeldig: CPU-frequentieschaling (DFS) actief\n");
+        }
+
+        PROFILE_PRINTF("  Histogram loop-periode:");
+        for (int i = 0; i < PROFILE_BUCKET_COUNT; i++) {
+            if (i < PROFILE_BUCKET_COUNT - 1) {
+                PROFILE_PRINTF(" <%lu:%lu", (unsigned long)PROFILE_BUCKETS_US[i], (unsigned long)s.histogram[i]);
+            } else {
+                PROFILE_PRINTF(" >=%lu:%lu", (unsigned long)PROFILE_BUCKETS_US[i - 1], (unsigned long)s.histogram[i]);
+            }
+        }
+        PROFILE_PRINTF(" (us)\n");
+        PROFILE_PRINTF("  Stalls (>= %lu us): %lu\n", (unsigned long)PROFILE_STALL_US, (unsigned long)s.stalls);
+        PROFILE_PRINTF("--------------------------------------------------\n");
+
+        for (int i = 0; i < s.zoneCount; i++) {
+            s.zones[i].reset();
+        }
+        s.loop.reset();
+        for (int i = 0; i < PROFILE_BUCKET_COUNT; i++) {
+            s.histogram[i] = 0;
+        }
+        s.stalls = 0;
+        s.lastReport = profileMillis();
+        s.cyclesValid = profileCyclesValid();
+        s.loopStarted = false;                            // Tijd van het overzicht zelf niet meetellen
+    }
+
+private:
+    struct State {
+        ProfileZone zones[PROFILE_MAX_ZONES];
+        int zoneCount;
+        ProfileZone loop;
+        uint32_t histogram[PROFILE_BUCKET_COUNT];
+        uint32_t stalls;
+        uint64_t lastLoop;
+        bool loopStarted;
+        unsigned long lastReport;
+        bool reportStarted;
+        bool cyclesValid;
+    };
+
+    static State& state() {
+        static State s = {};
+        return s;
+    }
+
+    // cyclesPerUs 0: cycles niet om te rekenen (DFS), alleen het aantal aanroepen
+    static void printZone(const ProfileZone& z, const char* name, uint32_t cyclesPerUs) {
+        const char* mark = z.wallClock ? "*" : " ";
+        uint32_t perUs = z.wallClock ? 1 : cyclesPerUs;
+        if (z.calls == 0 || perUs == 0) {
+            const char* none = z.calls == 0 ? "-" : "ongeldig";
+            PROFILE_PRINTF("  %-23s%s %8lu %10s %10s %10s\n", name, mark, (unsigned long)z.calls,
+                           none, none, none);
+            return;
+        }
+        PROFILE_PRINTF("  %-23s%s %8lu %10.2f %10.2f %10.2f\n", name, mark, (unsigned long)z.calls,
+                       (double)z.minTicks / perUs,
+                       (double)z.totalTicks / z.calls / perUs,
+                       (double)z.maxTicks / perUs);
+    }
+};
+
+// Meet de tijd tot het einde van het omringende blok, met de wandklok
+class ProfileWallScope {
+public:
+    explicit ProfileWallScope(ProfileZone* zone) : zone(zone), start(profileWallUs()) {}
+    ~ProfileWallScope() { zone->add(profileWallUs() - start); }
+
+private:
+    ProfileZone* zone;
+    uint64_t start;
+};
+
+// Meet de tijd tot het einde van het omringende blok, in cycles
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileZone* zone) : zone(zone), start(profileNow()) {}
+    ~ProfileScope() { zone->add(profileNow() - start); }
+
+private:
+    ProfileZone* zone;
+    ProfileTicks start;
+};
+
+// Pad over meerdere functies heen, bijv. van ontvangst van RING tot tone()
+class ProfileSpan {
+public:
+    explicit ProfileSpan(const char* name) : zone(Profiler::zone(name, false)) {}
+
+    void begin() {
+        start = profileNow();
+        started = true;
+    }
+
+    void end() {
+        if (!started) return;
+        zone->add(profileNow() - start);
+        started = false;
+    }
+
+private:
+    ProfileZone* zone;
+    ProfileTicks start = 0;
+    bool started = false;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#define PROFILE_ZONE(name)                                                               \
+    static ProfileZone* PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::zone(name, false); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+#define PROFILE_ZONE_WALL(name)                                                          \
+    static ProfileZone* PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::zone(name, true); \
+    ProfileWallScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+#define PROFILE_SPAN(var, name) ProfileSpan var(name)
+#define PROFILE_SPAN_BEGIN(var) (var).begin()
+#define PROFILE_SPAN_END(var) (var).end()
+#define PROFILE_LOOP() Profiler::loopTick()
+#define PROFILE_REPORT() Profiler::report()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_WALL(name)
+#define PROFILE_SPAN(var, name)
+#define PROFILE_SPAN_BEGIN(var)
+#define PROFILE_SPAN_END(var)
+#define PROFILE_LOOP()
+#define PROFILE_REPORT()
+
+#endif // DOORBELL_PROFILING
+
+#endif // DOORBELL_PROFILER_H
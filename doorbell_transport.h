@@ -0,0 +1,494 @@
+/**
+ * ESP32 Remote Deurbel - Transportlaag
+ * ============================================
+ *
+ * Gemeenschappelijke transportinterface voor zender en ontvanger.
+ * De RING/QSL-logica (zie doorbell_link.h) praat alleen tegen
+ * DoorbellTransport; welk netwerkmechanisme eronder zit wordt bij
+ * het compileren gekozen met DOORBELL_TRANSPORT.
+ *
+ * Beschikbare backends:
+ * - UdpTransport:      UDP-pakketten via het WiFi-netwerk (standaard);
+ *                      op de PC via POSIX sockets op localhost
+ * - HttpTransport:     HTTP GET-request, bevestiging in de HTTP response
+ * - EspNowTransport:   ESP-NOW, rechtstreeks tussen de ESP32's zonder router
+ * - LoopbackTransport: koppeling binnen hetzelfde programma (tests op de PC)
+ *
+ * Een frame is een korte tekst zoals "RING" of "QSL".
+ * Beide sketches moeten dezelfde DOORBELL_TRANSPORT gebruiken.
+ *
+ * Auteur: MiniMax Agent
+ * Datum: Januari 2026
+ */
+
+#ifndef DOORBELL_TRANSPORT_H
+#define DOORBELL_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+// ============================================
+// TRANSPORTKEUZE
+// ============================================
+
+#define TRANSPORT_UDP     1                               // UDP via WiFi-router
+#define TRANSPORT_HTTP    2                               // HTTP via WiFi-router
+#define TRANSPORT_ESPNOW  3                               // ESP-NOW, zonder router
+
+#ifndef DOORBELL_TRANSPORT
+#define DOORBELL_TRANSPORT TRANSPORT_UDP
+#endif
+
+const size_t DOORBELL_MAX_FRAME = 32;                     // Max frame lengte incl. afsluitende 0
+
+// ============================================
+// TRANSPORT INTERFACE
+// ============================================
+
+class DoorbellTransport {
+public:
+    virtual ~DoorbellTransport() {}
+
+    // Transport starten (socket openen, server starten, ESP-NOW initialiseren)
+    virtual bool begin() = 0;
+
+    // Eén frame versturen naar de andere unit
+    virtual bool sendFrame(const char* frame) = 0;
+
+    // Non-blocking: kopieert een ontvangen frame naar buffer (0-afgesloten)
+    // en geeft de lengte terug, of 0 als er niets binnen is
+    virtual size_t pollFrame(char* buffer, size_t maxLen) = 0;
+
+    // Kan het transport op dit moment frames versturen en ontvangen?
+    virtual bool linkUp() = 0;
+
+    // Hoe vaak een RING herhaald wordt (verbindingsloze transports verliezen pakketten)
+    virtual int redundancy() const { return 3; }
+
+    virtual const char* name() const = 0;
+};
+
+// ============================================
+// FRAME BUFFER
+// ============================================
+
+// Kleine ringbuffer voor ontvangen frames (loopback en ESP-NOW)
+struct FrameQueue {
+    static const size_t CAPACITY = 4;
+
+    char frames[CAPACITY][DOORBELL_MAX_FRAME];
+    size_t head = 0;
+    size_t count = 0;
+
+    bool push(const char* data, size_t len) {
+        if (count >= CAPACITY) return false;              // Vol: frame laten vallen
+        if (len >= DOORBELL_MAX_FRAME) len = DOORBELL_MAX_FRAME - 1;
+        char* slot = frames[(head + count) % CAPACITY];
+        memcpy(slot, data, len);
+        slot[len] = 0;
+        count++;
+        return true;
+    }
+
+    size_t pop(char* buffer, size_t maxLen) {
+        if (count == 0 || maxLen == 0) return 0;
+        const char* slot = frames[head];
+        size_t len = strlen(slot);
+        if (len >= maxLen) len = maxLen - 1;
+        memcpy(buffer, slot, len);
+        buffer[len] = 0;
+        head = (head + 1) % CAPACITY;
+        count--;
+        return len;
+    }
+};
+
+// ============================================
+// LOOPBACK (IN-PROCESS)
+// ============================================
+
+// Twee gekoppelde instanties leveren frames rechtstreeks bij elkaar af
+class LoopbackTransport : public DoorbellTransport {
+public:
+    void connect(LoopbackTransport& other) {
+        peer = &other;
+        other.peer = this;
+    }
+
+    bool begin() override { return true; }
+
+    bool sendFrame(const char* frame) override {
+        return peer != nullptr && peer->inbox.push(frame, strlen(frame));
+    }
+
+    size_t pollFrame(char* buffer, size_t maxLen) override {
+        return inbox.pop(buffer, maxLen);
+    }
+
+    bool linkUp() override { return peer != nullptr; }
+
+    int redundancy() const override { return 1; }         // Verliest nooit frames
+
+    const char* name() const override { return "Loopback"; }
+
+private:
+    LoopbackTransport* peer = nullptr;
+    FrameQueue inbox;
+};
+
+#ifdef ARDUINO
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <WiFiClient.h>
+#include <WiFiServer.h>
+#include <esp_now.h>
+
+// ============================================
+// UDP
+// ============================================
+
+// Eén socket op udpPort voor zowel verzenden als ontvangen
+class UdpTransport : public DoorbellTransport {
+public:
+    UdpTransport(IPAddress remote, uint16_t port) : remoteIp(remote), port(port) {}
+
+    bool begin() override {
+        udp.stop();
+        return udp.begin(port) == 1;
+    }
+
+    bool sendFrame(const char* frame) override {
+        if (!udp.beginPacket(remoteIp, port)) return false;
+        udp.print(frame);
+        return udp.endPacket() == 1;
+    }
+
+    size_t pollFrame(char* buffer, size_t maxLen) override {
+        if (udp.parsePacket() <= 0) return 0;
+        int len = udp.read(buffer, maxLen - 1);
+        if (len <= 0) return 0;
+        buffer[len] = 0;
+        return len;
+    }
+
+    bool linkUp() override { return WiFi.status() == WL_CONNECTED; }
+
+    const char* name() const override { return "UDP"; }
+
+private:
+    IPAddress remoteIp;
+    uint16_t port;
+    WiFiUDP udp;
+};
+
+// ============================================
+// HTTP
+// ============================================
+
+// Frame "RING" wordt "GET /ring"; de andere unit antwoordt met het
+// volgende frame (bijv. "QSL") als body van de HTTP response.
+// Beide units draaien dus zowel een server als een client.
+// Requests en responses worden per poll ingelezen voor zover ze binnen zijn,
+// zodat loop() nooit op het netwerk wacht (alleen connect() blokkeert kort).
+const int32_t HTTP_CONNECT_TIMEOUT = 250;                 // Max wachttijd op TCP connect (ms)
+const size_t HTTP_MAX_MESSAGE = 512;                      // Langere requests/responses worden afgekapt
+
+class HttpTransport : public DoorbellTransport {
+public:
+    HttpTransport(IPAddress remote, uint16_t port) : remoteIp(remote), port(port), server(port) {}
+
+    bool begin() override {
+        server.begin();
+        return true;
+    }
+
+    bool sendFrame(const char* frame) override {
+        // Staat er nog een request van de andere kant open, dan is dit frame het antwoord
+        if (inboundPending) {
+            sendResponse("200 OK", frame);
+            return true;
+        }
+
+        // Anders een nieuwe request naar de andere unit; korte timeout zodat
+        // een onbereikbare ontvanger de loop niet seconden lang stil zet
+        outbound.stop();
+        responseBuf = "";
+        if (!outbound.connect(remoteIp, port, HTTP_CONNECT_TIMEOUT)) return false;
+
+        outbound.print("GET /");
+        for (const char* p = frame; *p; p++) {
+            outbound.print((char)tolower(*p));
+        }
+        outbound.println(" HTTP/1.1");
+        outbound.print("Host: ");
+        outbound.println(remoteIp);
+        outbound.println("Connection: close");
+        outbound.println();
+        return true;
+    }
+
+    size_t pollFrame(char* buffer, size_t maxLen) override {
+        // Request die niet beantwoord is: afsluiten zodat de client niet blijft hangen
+        if (inboundPending) {
+            sendResponse("204 No Content", "");
+        }
+
+        size_t len = readResponse(buffer, maxLen);
+        if (len > 0) return len;
+
+        return readRequest(buffer, maxLen);
+    }
+
+    bool linkUp() override { return WiFi.status() == WL_CONNECTED; }
+
+    int redundancy() const override { return 1; }         // TCP levert zelf betrouwbaar af
+
+    const char* name() const override { return "HTTP"; }
+
+private:
+    IPAddress remoteIp;
+    uint16_t port;
+    WiFiServer server;
+    WiFiClient inbound;                                   // Request van de andere unit
+    WiFiClient outbound;                                  // Onze request naar de andere unit
+    bool inboundPending = false;
+    String requestBuf;                                    // Deels ontvangen request
+    String responseBuf;                                   // Deels ontvangen response
+
+    void sendResponse(const char* status, const char* body) {
+        inbound.print("HTTP/1.1 ");
+        inbound.println(status);
+        inbound.println("Content-Type: text/plain");
+        inbound.println("Connection: close");
+        inbound.println();
+        if (*body) inbound.println(body);
+        inbound.stop();
+        inboundPending = false;
+    }
+
+    // Alles lezen wat nu binnen is, zonder te wachten; boven HTTP_MAX_MESSAGE
+    // wordt de rest gelezen en weggegooid
+    static void readAvailable(WiFiClient& client, String& buf) {
+        while (client.available()) {
+            char c = client.read();
+            if (buf.length() < HTTP_MAX_MESSAGE) buf += c;
+        }
+    }
+
+    // Body van de response op onze eigen request is het ontvangen frame
+    size_t readResponse(char* buffer, size_t maxLen) {
+        readAvailable(outbound, responseBuf);
+        if (responseBuf.length() == 0) return 0;
+
+        // Compleet als de body-regel binnen is of de server de verbinding sloot
+        bool closed = !outbound.connected();
+        int headerEnd = responseBuf.indexOf("\r\n\r\n");
+        int bodyEnd = headerEnd < 0 ? -1 : responseBuf.indexOf('\n', headerEnd + 4);
+        if (bodyEnd < 0 && !closed && responseBuf.length() < HTTP_MAX_MESSAGE) return 0;
+
+        String status = responseBuf.substring(0, responseBuf.indexOf('\n'));
+        String body = headerEnd < 0 ? String()
+                    : responseBuf.substring(headerEnd + 4, bodyEnd < 0 ? responseBuf.length() : bodyEnd);
+        body.trim();
+        outbound.stop();
+        responseBuf = "";
+
+        if (status.indexOf(" 200 ") < 0 || body.length() == 0) return 0;
+        return copyFrame(body, buffer, maxLen);
+    }
+
+    // Pad van een binnenkomende GET request is het ontvangen frame
+    size_t readRequest(char* buffer, size_t maxLen) {
+        if (!inbound) {
+            inbound = server.available();
+            if (!inbound) return 0;
+            requestBuf = "";
+        }
+
+        // Pas antwoorden als de headers tot de lege regel gelezen zijn: sluiten
+        // met ongelezen data laat lwIP een RST sturen en dan kan de client
+        // het antwoord kwijtraken
+        readAvailable(inbound, requestBuf);
+        if (requestBuf.indexOf("\r\n\r\n") < 0 && requestBuf.length() < HTTP_MAX_MESSAGE) {
+            if (!inbound.connected()) {
+                inbound.stop();
+                requestBuf = "";
+            }
+            return 0;
+        }
+
+        String request = requestBuf.substring(0, requestBuf.indexOf('\r'));
+        requestBuf = "";
+        int pathEnd = request.indexOf(' ', 5);
+        if (!request.startsWith("GET /") || pathEnd <= 5) {
+            inboundPending = true;
+            sendResponse("404 Not Found", "Not Found");
+            return 0;
+        }
+
+        String path = request.substring(5, pathEnd);
+        path.toUpperCase();
+        inboundPending = true;
+        return copyFrame(path, buffer, maxLen);
+    }
+
+    static size_t copyFrame(const String& frame, char* buffer, size_t maxLen) {
+        size_t len = frame.length();
+        if (len >= maxLen) len = maxLen - 1;
+        memcpy(buffer, frame.c_str(), len);
+        buffer[len] = 0;
+        return len;
+    }
+};
+
+// ============================================
+// ESP-NOW
+// ============================================
+
+// Verbindingsloos en onafhankelijk van de router: frames gaan rechtstreeks
+// naar het MAC-adres van de andere unit (of broadcast FF:FF:FF:FF:FF:FF).
+// Zonder router gebruiken beide units het standaard WiFi-kanaal; met router
+// moeten ze op hetzelfde kanaal als het access point zitten.
+class EspNowTransport : public DoorbellTransport {
+public:
+    explicit EspNowTransport(const uint8_t peer[6]) {
+        memcpy(peerMac, peer, sizeof(peerMac));
+    }
+
+    bool begin() override {
+        if (WiFi.getMode() == WIFI_OFF) {
+            WiFi.mode(WIFI_STA);
+        }
+        if (esp_now_init() != ESP_OK) return false;
+        esp_now_register_recv_cb(onReceive);
+
+        if (!esp_now_is_peer_exist(peerMac)) {
+            esp_now_peer_info_t peerInfo = {};
+            memcpy(peerInfo.peer_addr, peerMac, sizeof(peerMac));
+            peerInfo.channel = 0;                         // Huidig WiFi-kanaal
+            peerInfo.encrypt = false;
+            if (esp_now_add_peer(&peerInfo) != ESP_OK) return false;
+        }
+        started = true;
+        return true;
+    }
+
+    bool sendFrame(const char* frame) override {
+        return esp_now_send(peerMac, (const uint8_t*)frame, strlen(frame)) == ESP_OK;
+    }
+
+    size_t pollFrame(char* buffer, size_t maxLen) override {
+        portENTER_CRITICAL(&rxLock());
+        size_t len = rxQueue().pop(buffer, maxLen);
+        portEXIT_CRITICAL(&rxLock());
+        return len;
+    }
+
+    bool linkUp() override { return started; }
+
+    const char* name() const override { return "ESP-NOW"; }
+
+private:
+    uint8_t peerMac[6];
+    bool started = false;
+
+    // Callback draait in de WiFi-task; ontvangen frames gaan via een gedeelde wachtrij
+    static FrameQueue& rxQueue() {
+        static FrameQueue queue;
+        return queue;
+    }
+
+    static portMUX_TYPE& rxLock() {
+        static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+        return lock;
+    }
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    static void onReceive(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+#else
+    static void onReceive(const uint8_t* mac, const uint8_t* data, int len) {
+#endif
+        if (len <= 0) return;
+        portENTER_CRITICAL(&rxLock());
+        rxQueue().push((const char*)data, len);
+        portEXIT_CRITICAL(&rxLock());
+    }
+};
+
+#else
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ============================================
+// UDP (PC, POSIX sockets)
+// ============================================
+
+// Zelfde protocol als de ESP32-versie, voor tests op de PC via localhost.
+// Beide kanten draaien op één machine en hebben daarom elk een eigen poort.
+class UdpTransport : public DoorbellTransport {
+public:
+    UdpTransport(const char* remoteHost, uint16_t remotePort, uint16_t localPort)
+        : localPort(localPort) {
+        memset(&remoteAddr, 0, sizeof(remoteAddr));
+        remoteAddr.sin_family = AF_INET;
+        remoteAddr.sin_port = htons(remotePort);
+        inet_pton(AF_INET, remoteHost, &remoteAddr.sin_addr);
+    }
+
+    ~UdpTransport() override {
+        if (sock >= 0) close(sock);
+    }
+
+    bool begin() override {
+        if (sock >= 0) close(sock);
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock < 0) return false;
+
+        sockaddr_in localAddr;
+        memset(&localAddr, 0, sizeof(localAddr));
+        localAddr.sin_family = AF_INET;
+        localAddr.sin_port = htons(localPort);
+        localAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(sock, (const sockaddr*)&localAddr, sizeof(localAddr)) != 0) {
+            close(sock);
+            sock = -1;
+            return false;
+        }
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+        return true;
+    }
+
+    bool sendFrame(const char* frame) override {
+        if (sock < 0) return false;
+        size_t len = strlen(frame);
+        return sendto(sock, frame, len, 0, (const sockaddr*)&remoteAddr, sizeof(remoteAddr)) == (ssize_t)len;
+    }
+
+    size_t pollFrame(char* buffer, size_t maxLen) override {
+        if (sock < 0 || maxLen == 0) return 0;
+        ssize_t len = recv(sock, buffer, maxLen - 1, 0);
+        if (len <= 0) return 0;
+        buffer[len] = 0;
+        return len;
+    }
+
+    bool linkUp() override { return sock >= 0; }
+
+    const char* name() const override { return "UDP"; }
+
+private:
+    uint16_t localPort;
+    sockaddr_in remoteAddr;
+    int sock = -1;
+};
+
+#endif // ARDUINO
+
+#endif // DOORBELL_TRANSPORT_H
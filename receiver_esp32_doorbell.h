@@ -3,20 +3,21 @@
  * ============================================
  * 
  * Dit is de ontvangereenheid die op zolder wordt geplaatst.
- * Het systeem fungeert als HTTP-webserver en luistert naar GET-requests
- * op het pad /ring van de zender.
+ * Het systeem luistert naar "RING" signalen van de zender via het gekozen
+ * transport (UDP, HTTP GET /ring of ESP-NOW, zie DOORBELL_TRANSPORT).
  * 
  * Na ontvangst van een geldige request wordt de melodie geactiveerd
  * en wordt een bevestigingsteruggezonden naar de zender.
  * 
  * Functionaliteiten:
- * - HTTP-webserver voor signaalontvangst
+ * - Signaalontvangst via UDP, HTTP of ESP-NOW
  * - Non-blocking melodie afspeel functie met Arduino tone()
  * - Vier-tonige melodie: C, E, G, High C
  * - Automatische WiFi herverbinding bij verbindingsverlies
  * - Visuele LED feedback
- * - Bevestiging terugsturen naar zender via HTTP response
+ * - Bevestiging (QSL) terugsturen naar zender
  * - Deurbel-indicator LED knippert 60s na elke activatie
+ * - Instelbaar energieprofiel (standaard low-latency: radio altijd aan)
  * 
  * Hardware: ESP32 Lite bordje
  * Pin aansluitingen:
@@ -45,9 +46,22 @@ IPAddress dns(8, 8, 8, 8);                              // Google DNS (fallback)
 IPAddress ip_sender(192, 168, 170, 201);                // Zender (voordeur)
 IPAddress ip_receiver(192, 168, 170, 202);              // Ontvanger (zolder)
 
-// HTTP-instellingen
-const int httpPort = 80;                                // HTTP poort
-const char* doorbellPath = "/ring";                     // URL path voor deurbel signaal
+// Transport (moet gelijk zijn aan de zender): TRANSPORT_UDP, TRANSPORT_HTTP of TRANSPORT_ESPNOW
+#define DOORBELL_TRANSPORT TRANSPORT_UDP
+
+// UDP/HTTP-instellingen
+const int udpPort = 4210;                               // Poort voor UDP communicatie
+const int httpPort = 80;                                // Poort voor HTTP communicatie (GET /ring)
+
+// ESP-NOW: MAC adres van de zender (broadcast werkt ook)
+const uint8_t espNowPeer[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Energieprofiel: POWER_LOW_LATENCY, POWER_BALANCED of POWER_BATTERY
+// De ontvanger draait op netvoeding; zonder wake-knop wordt POWER_BATTERY balanced.
+#define DOORBELL_POWER_PROFILE POWER_LOW_LATENCY
+
+// Profiler voor loop() (zie doorbell_profiler.h); uitgecommentarieerd = niets meegecompileerd
+// #define DOORBELL_PROFILING
 
 // ============================================
 // PIN EN BUZZER CONFIGURATIE
@@ -86,12 +100,26 @@ const int MELODY_LENGTH = sizeof(MELODY) / sizeof(MELODY[0]);
 // ============================================
 
 #include <WiFi.h>
-#include <WiFiClient.h>
-#include <WiFiServer.h>
+#include "doorbell_transport.h"
+#include "doorbell_link.h"
+#include "doorbell_power.h"
+#include "doorbell_profiler.h"
 
-// WiFi variabelen
-WiFiServer server(httpPort);
-WiFiClient client;
+// Transport variabelen
+#if DOORBELL_TRANSPORT == TRANSPORT_HTTP
+HttpTransport transport(ip_sender, httpPort);
+#elif DOORBELL_TRANSPORT == TRANSPORT_ESPNOW
+EspNowTransport transport(espNowPeer);
+#else
+UdpTransport transport(ip_sender, udpPort);
+#endif
+DoorbellLink doorbellLink(transport, 0);                // Ontvanger wacht niet op ACK
+
+// Energiebeheer (geen wake-knop op de ontvanger)
+PowerManager power(-1);
+
+// Profiler: pad van ontvangst van het frame tot de eerste noot
+PROFILE_SPAN(ringToTone, "RING-naar-toon");
 
 // WiFi status tracking
 bool wifiWasConnected = false;
@@ -142,6 +170,7 @@ void setup() {
         delay(100);
     }
     
+#if DOORBELL_TRANSPORT != TRANSPORT_ESPNOW
     // Statisch IP configureren
     Serial.println("Statische IP configureren...");
     if (!WiFi.config(ip_receiver, gateway, subnet, dns)) {
@@ -179,25 +208,39 @@ void setup() {
     Serial.println(WiFi.localIP());
     Serial.print("MAC adres: ");
     Serial.println(WiFi.macAddress());
-    Serial.print("HTTP Server gestart op: http://");
-    Serial.print(ip_receiver);
-    Serial.print(doorbellPath);
-    Serial.print(":");
-    Serial.println(httpPort);
     Serial.print("Verwacht signalen van: ");
     Serial.println(ip_sender);
     Serial.println("----------------------------------------");
+#else
+    digitalWrite(RECEIVER_LED_PIN, HIGH);
+    digitalWrite(NETWORK_LED_PIN, HIGH);
+    wifiWasConnected = true;
+    Serial.println("ESP-NOW: geen WiFi-router nodig");
+    Serial.print("MAC adres: ");
+    Serial.println(WiFi.macAddress());
+#endif
+    
+    // Transport starten
+    if (!doorbellLink.begin()) {
+        Serial.println("FOUT: Kon transport niet starten!");
+        while (true);                                  // Blokkeer bij fout
+    }
+    Serial.print("Transport: ");
+    Serial.println(doorbellLink.transportName());
     
-    // HTTP server starten
-    server.begin();
+    // Energieprofiel instellen (wisselen via seriële monitor: 1, 2, 3; rapport: p)
+    power.apply(DOORBELL_POWER_PROFILE);
     Serial.println();
     Serial.println("Systeem is klaar voor gebruik!");
     Serial.println();
 }
 
 void loop() {
-    // WiFi verbindingsstatus controleren
-    if (WiFi.status() != WL_CONNECTED) {
+    PROFILE_LOOP();
+    PROFILE_REPORT();
+    
+    // Verbindingsstatus controleren
+    if (!doorbellLink.linkUp()) {
         if (wifiWasConnected) {
             Serial.println("Waarschuwing: WiFi verbinding verbroken!");
             wifiWasConnected = false;
@@ -209,54 +252,23 @@ void loop() {
             Serial.println("WiFi weer verbonden!");
             wifiWasConnected = true;
             digitalWrite(NETWORK_LED_PIN, HIGH);        // Netwerk LED weer inschakelen
-            server.begin();                            // HTTP server opnieuw starten na reconnect
+            doorbellLink.begin();                      // Transport opnieuw starten na reconnect
         }
     }
     
-    // Controleren of er een HTTP-client verbinding maakt
-    client = server.available();
+    // Controleren op inkomende frames; QSL wordt direct teruggestuurd
+    DoorbellEvent event = pollDoorbellLink();
     
-    if (client) {
-        Serial.println("Client verbonden!");
-        
-        // Wacht tot er data beschikbaar is
-        while (!client.available()) {
-            delay(1);
-        }
-        
-        // Lees de request
-        String request = client.readStringUntil('\r');
-        Serial.print("Request ontvangen: ");
-        Serial.println(request);
-        
-        // Controleer of het een GET request is op /ring
-        if (request.indexOf("GET /ring") >= 0 || request.indexOf("GET /ring ") >= 0) {
-            Serial.println(">>> DEURBEL SIGNAAL ONTVANGEN! <<<");
-            startMelody();
-            
-            // Stuur HTTP 200 OK response met QSL bevestiging
-            Serial.println("Versturen van bevestiging (QSL)...");
-            client.println("HTTP/1.1 200 OK");
-            client.println("Content-Type: text/plain");
-            client.println("Connection: close");
-            client.println();
-            client.println("QSL");
-            
-            // Start deurbel-indicator (LED knippert 60 seconden)
-            startDoorbellIndicator();
-        } else {
-            // Onbekende request, stuur 404
-            client.println("HTTP/1.1 404 Not Found");
-            client.println("Content-Type: text/plain");
-            client.println("Connection: close");
-            client.println();
-            client.println("Not Found");
-        }
+    if (event == DOORBELL_RING) {
+        Serial.println(">>> DEURBEL SIGNAAL ONTVANGEN! <<<");
+        Serial.println("Bevestiging (QSL) verstuurd");
+        startMelody();
         
-        // Kleine vertraging en verbinding sluiten
-        delay(100);
-        client.stop();
-        Serial.println("Client verwerkt en verbroken");
+        // Start deurbel-indicator (LED knippert 60 seconden)
+        startDoorbellIndicator();
+    } else if (event == DOORBELL_UNKNOWN) {
+        Serial.print("Onbekend signaal ontvangen: ");
+        Serial.println(doorbellLink.lastFrame());
     }
     
     // Non-blocking melodie update
@@ -264,9 +276,26 @@ void loop() {
     
     // Non-blocking deurbel-indicator update
     updateDoorbellIndicator();
+    
+    // Seriële commando's, energierapport en eventueel light sleep
+    power.update();
+    {
+        PROFILE_ZONE_WALL("power.idle");       // Alleen idle(); kan slapen: wandklok
+        power.idle(!isPlayingMelody && !doorbellIndicatorActive);
+    }
+    if (power.radioWasRestarted()) {
+        doorbellLink.begin();                          // Transport opnieuw openen na WiFi herstart
+    }
+}
+
+DoorbellEvent pollDoorbellLink() {
+    PROFILE_ZONE("doorbellLink.poll");
+    PROFILE_SPAN_BEGIN(ringToTone);                    // Eindigt alleen als RING tot tone() leidt
+    return doorbellLink.poll(millis());
 }
 
 void startMelody() {
+    PROFILE_ZONE("startMelody");
     // Voorkom dat melodie opnieuw start als hij al speelt
     if (!isPlayingMelody) {
         Serial.println();
@@ -295,6 +324,7 @@ void startMelody() {
         Serial.println(" ms");
         
         tone(BUZZER_PIN, firstNote.frequency);
+        PROFILE_SPAN_END(ringToTone);
         
         digitalWrite(RECEIVER_LED_PIN, LOW);             // LED uit tijdens melodie
     } else {
@@ -303,6 +333,7 @@ void startMelody() {
 }
 
 void updateMelody() {
+    PROFILE_ZONE("updateMelody");
     if (!isPlayingMelody) return;
     
     unsigned long elapsedTime = millis() - melodyStartTime;
@@ -361,6 +392,7 @@ void startDoorbellIndicator() {
 }
 
 void updateDoorbellIndicator() {
+    PROFILE_ZONE("updateDoorbellIndicator");
     if (!doorbellIndicatorActive) return;
     
     unsigned long elapsedTime = millis() - doorbellIndicatorStartTime;
@@ -396,6 +428,7 @@ String getNoteName(int frequency) {
 }
 
 void handleDisconnection() {
+    PROFILE_ZONE("handleDisconnection");
     static unsigned long lastReconnectAttempt = 0;
     
     // LED knippert langzaam bij verbindingsproblemen
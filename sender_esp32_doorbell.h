@@ -4,7 +4,8 @@
  * 
  * Dit is de zendereenheid die bij de voordeur wordt geplaatst.
  * Wanneer op de drukknop wordt gedrukt, verstuurt dit systeem
- * een UDP "RING" signaal naar de ontvanger op zolder.
+ * een "RING" signaal naar de ontvanger op zolder (UDP, HTTP of ESP-NOW,
+ * zie DOORBELL_TRANSPORT).
  * 
  * Na verzending wacht de zender op een bevestiging "QSL" van de ontvanger.
  * Bij ontvangst van QSL wordt de groene LED op pin 16 geactiveerd.
@@ -16,6 +17,7 @@
  * - Automatische WiFi herverbinding bij verbindingsverlies
  * - Visuele LED feedback (LED op pin 22 = status, LED op pin 16 = bevestiging)
  * - Ontvangstbevestiging (QSL) van ontvanger
+ * - Instelbaar energieprofiel (standaard battery: light sleep, wake via drukknop)
  * 
  * Hardware: ESP32 Lite bordje
  * Pin aansluitingen:
@@ -44,10 +46,21 @@ IPAddress dns(8, 8, 8, 8);                            // Google DNS (fallback)
 IPAddress ip_sender(192, 168, 2, 201);                // Zender (voordeur)
 IPAddress ip_receiver(192, 168, 2, 202);              // Ontvanger (zolder)
 
-// UDP-instellingen
-const int udpPort = 4210;                             // Poort voor communicatie
-const char* doorbellPayload = "RING";                 // Signaal payload
-const char* ackPayload = "QSL";                       // Bevestiging payload
+// Transport (moet gelijk zijn aan de ontvanger): TRANSPORT_UDP, TRANSPORT_HTTP of TRANSPORT_ESPNOW
+#define DOORBELL_TRANSPORT TRANSPORT_UDP
+
+// UDP/HTTP-instellingen
+const int udpPort = 4210;                             // Poort voor UDP communicatie
+const int httpPort = 80;                              // Poort voor HTTP communicatie
+
+// ESP-NOW: MAC adres van de ontvanger (broadcast werkt ook)
+const uint8_t espNowPeer[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Energieprofiel: POWER_LOW_LATENCY, POWER_BALANCED of POWER_BATTERY
+#define DOORBELL_POWER_PROFILE POWER_BATTERY
+
+// Profiler voor loop() (zie doorbell_profiler.h); uitgecommentarieerd = niets meegecompileerd
+// #define DOORBELL_PROFILING
 
 // Pin definities
 const int BUTTON_PIN = 13;                            // Drukknop op GPIO 13
@@ -59,10 +72,18 @@ const int ACK_LED_PIN = 16;                           // Bevestigings LED (groen
 // ============================================
 
 #include <WiFi.h>
-#include <WiFiUdp.h>
+#include "doorbell_transport.h"
+#include "doorbell_link.h"
+#include "doorbell_power.h"
+#include "doorbell_profiler.h"
 
-WiFiUDP udp;
-WiFiUDP udpReceive;                                   // Separate UDP instance voor ontvangst
+#if DOORBELL_TRANSPORT == TRANSPORT_HTTP
+HttpTransport transport(ip_receiver, httpPort);
+#elif DOORBELL_TRANSPORT == TRANSPORT_ESPNOW
+EspNowTransport transport(espNowPeer);
+#else
+UdpTransport transport(ip_receiver, udpPort);
+#endif
 
 // Pin status variabelen
 int lastButtonState = HIGH;                           // Vorige knopstatus (HIGH = niet ingedrukt)
@@ -79,10 +100,17 @@ unsigned long ackLedStartTime = 0;
 bool ackLedActive = false;
 const unsigned long ACK_LED_DURATION = 2000;          // Hoe lang de groene LED blijft branden
 
+// Status LED flits bij verzenden (non-blocking)
+unsigned long ringFlashStartTime = 0;
+bool ringFlashActive = false;
+const unsigned long RING_FLASH_DURATION = 150;        // Hoe lang de status LED uit gaat
+
 // Wachten op ACK
-bool waitingForAck = false;
-unsigned long ackWaitStartTime = 0;
 const unsigned long ACK_TIMEOUT = 2000;               // Timeout voor ACK ontvangst (ms)
+DoorbellLink doorbellLink(transport, ACK_TIMEOUT);
+
+// Energiebeheer (drukknop wekt de zender uit light sleep)
+PowerManager power(BUTTON_PIN);
 
 void setup() {
     // Seriële communicatie starten voor debugging
@@ -117,6 +145,7 @@ void setup() {
         delay(100);
     }
     
+#if DOORBELL_TRANSPORT != TRANSPORT_ESPNOW
     // Statisch IP configureren
     Serial.println("Statische IP configureren...");
     if (!WiFi.config(ip_sender, gateway, subnet, dns)) {
@@ -153,31 +182,49 @@ void setup() {
     Serial.print("MAC adres: ");
     Serial.println(WiFi.macAddress());
     Serial.print("Zend naar: ");
-    Serial.print(ip_receiver);
-    Serial.print(":");
-    Serial.println(udpPort);
+    Serial.println(ip_receiver);
     Serial.println("----------------------------------------");
+#else
+    digitalWrite(SENDER_LED_PIN, HIGH);
+    Serial.println("ESP-NOW: geen WiFi-router nodig");
+    Serial.print("MAC adres: ");
+    Serial.println(WiFi.macAddress());
+#endif
     
-    // UDP luisteraar starten voor ontvangst van QSL
-    udpReceive.begin(udpPort);
-    Serial.println("Luisteren op poort " + String(udpPort) + " voor bevestigingen");
+    // Transport starten voor verzenden van RING en ontvangst van QSL
+    if (!doorbellLink.begin()) {
+        Serial.println("FOUT: Kon transport niet starten!");
+        while (true);                                // Blokkeer bij fout
+    }
+    Serial.print("Transport: ");
+    Serial.println(doorbellLink.transportName());
+    
+    // Energieprofiel instellen (wisselen via seriële monitor: 1, 2, 3; rapport: p)
+    power.apply(DOORBELL_POWER_PROFILE);
     Serial.println();
     Serial.println("Systeem is klaar voor gebruik!");
     Serial.println();
 }
 
 void loop() {
-    // WiFi verbindingsstatus controleren
-    if (WiFi.status() != WL_CONNECTED) {
+    PROFILE_LOOP();
+    PROFILE_REPORT();
+    
+    // Verbindingsstatus controleren
+    if (!doorbellLink.linkUp()) {
         handleDisconnection();
         return;
     }
     
-    // Controleren op inkomende UDP pakketten (QSL bevestigingen)
+    // Seriële commando's en periodiek energierapport
+    power.update();
+    
+    // Controleren op inkomende frames (QSL bevestigingen) en ACK timeout
     checkForAck();
     
     // Update ACK LED timer
     updateAckLed();
+    updateRingFlash();
     
     // Drukknop uitlezen
     int reading = digitalRead(BUTTON_PIN);
@@ -187,88 +234,110 @@ void loop() {
         lastDebounceTime = millis();
     }
     
+    // Eerste LOW-lezing is het begin van de wake-naar-TX meting
+    if (reading == LOW && lastButtonState == HIGH) {
+        power.markPress(millis());
+    }
+    
     // Na de debounce-tijd: is de status nog steeds stabiel?
     if ((millis() - lastDebounceTime) > DEBOUNCE_DELAY) {
         // Knop is ingedrukt (LOW bij pull-up) en nog niet verwerkt
         if (reading == LOW && !buttonProcessed) {
-            // Check anti-spam timing
-            if (millis() - lastSignalTime > ANTI_SPAM_DELAY) {
-                sendDoorbellSignal();
-                lastSignalTime = millis();
-            } else {
-                Serial.println("Anti-spam: signaal geblokkeerd (nog geen 2 seconden)");
-            }
-            buttonProcessed = true;
+            handleButtonPress();
         }
         
         // Reset de verwerkingsflag wanneer knop wordt losgelaten
         if (reading == HIGH) {
             buttonProcessed = false;
+            power.clearPress();
         }
     }
     
     // Huidige status opslaan voor volgende iteratie
     lastButtonState = reading;
     
-    // Check ACK timeout
-    if (waitingForAck && (millis() - ackWaitStartTime > ACK_TIMEOUT)) {
-        Serial.println("WAARSCHUWING: Geen bevestiging (QSL) ontvangen van ontvanger!");
-        waitingForAck = false;
+    // Light sleep (alleen battery-profiel) als er niets meer loopt
+    bool buttonIdle = reading == HIGH && (millis() - lastDebounceTime) > DEBOUNCE_DELAY;
+    PowerWake wake;
+    {
+        PROFILE_ZONE_WALL("power.idle");       // Alleen idle(); kan slapen: wandklok
+        wake = power.idle(buttonIdle && !doorbellLink.waitingForAck() && !ackLedActive && !ringFlashActive);
+    }
+    
+    // Na handmatige light sleep is WiFi herstart: transport opnieuw openen
+    if (power.radioWasRestarted()) {
+        doorbellLink.begin();
     }
+    
+    // Gewekt door de knop: de druk kan al voorbij zijn tijdens het herverbinden
+    if (wake == POWER_WAKE_BUTTON && !buttonProcessed) {
+        handleButtonPress();
+    }
+}
+
+void handleButtonPress() {
+    // Check anti-spam timing
+    if (millis() - lastSignalTime > ANTI_SPAM_DELAY) {
+        sendDoorbellSignal();
+        lastSignalTime = millis();
+    } else {
+        Serial.println("Anti-spam: signaal geblokkeerd (nog geen 2 seconden)");
+    }
+    buttonProcessed = true;
 }
 
 void sendDoorbellSignal() {
+    PROFILE_ZONE("sendDoorbellSignal");
     Serial.println(">>> Deurbel ingedrukt! Signaal wordt verzonden...");
-    waitingForAck = true;
-    ackWaitStartTime = millis();
+    Serial.print("  Transport: ");
+    Serial.println(doorbellLink.transportName());
     
-    // Verstuur het signaal 3 keer voor redundantie (UDP is niet gegarandeerd)
-    for (int i = 0; i < 3; i++) {
-        udp.beginPacket(ip_receiver, udpPort);
-        udp.print(doorbellPayload);
-        udp.endPacket();
-        
-        // Visuele feedback: korte LED flits
-        digitalWrite(SENDER_LED_PIN, LOW);
-        delay(50);
+    // Visuele feedback: korte LED flits, wordt in updateRingFlash() beeindigd
+    digitalWrite(SENDER_LED_PIN, LOW);
+    ringFlashStartTime = millis();
+    ringFlashActive = true;
+    
+    // Verstuur RING als laatste stap, zodat de RING-naar-QSL tijd alleen de
+    // verbinding meet. Herhalingen (UDP, ESP-NOW) volgen vanuit checkForAck().
+    if (!doorbellLink.sendRing(millis())) {
+        Serial.println("  FOUT: RING niet verzonden");
+    }
+    power.recordTx(millis());
+}
+
+void updateRingFlash() {
+    if (ringFlashActive && (millis() - ringFlashStartTime > RING_FLASH_DURATION)) {
         digitalWrite(SENDER_LED_PIN, HIGH);
-        delay(50);
-        
-        Serial.print("  Pakket ");
-        Serial.print(i + 1);
-        Serial.println(" verzonden");
+        ringFlashActive = false;
     }
-    
-    Serial.println(">>> Alle signalen verzonden naar ontvanger");
-    Serial.print("  Doel: ");
-    Serial.print(ip_receiver);
-    Serial.print(":");
-    Serial.println(udpPort);
-    Serial.println("  Wachten op bevestiging (QSL)...");
-    Serial.println();
 }
 
 void checkForAck() {
-    char packetBuffer[255];
-    int packetSize = udpReceive.parsePacket();
+    PROFILE_ZONE("checkForAck");
+    DoorbellEvent event = doorbellLink.poll(millis());
     
-    if (packetSize) {
-        int len = udpReceive.read(packetBuffer, 255);
-        if (len > 0) {
-            packetBuffer[len] = 0;
-        }
-        
-        Serial.print("Ontvangen: ");
-        Serial.print(packetBuffer);
-        Serial.print(" van ");
-        Serial.println(udpReceive.remoteIP().toString());
-        
-        // Check of het een QSL bevestiging is
-        if (strcmp(packetBuffer, ackPayload) == 0) {
+    switch (event) {
+        case DOORBELL_ACK:
+            Serial.print("Ontvangen: ");
+            Serial.println(doorbellLink.lastFrame());
             Serial.println(">>> BEVESTIGING ONTVANGEN: QSL <<<");
+            Serial.print("  RING-naar-QSL tijd: ");
+            Serial.print(doorbellLink.lastAckLatency());
+            Serial.println(" ms");
+            power.recordAck(doorbellLink.lastAckLatency());
             activateAckLed();
-            waitingForAck = false;
-        }
+            break;
+        case DOORBELL_ACK_TIMEOUT:
+            Serial.println("WAARSCHUWING: Geen bevestiging (QSL) ontvangen van ontvanger!");
+            power.releaseRadio();
+            break;
+        case DOORBELL_RING:
+        case DOORBELL_UNKNOWN:
+            Serial.print("Ontvangen: ");
+            Serial.println(doorbellLink.lastFrame());
+            break;
+        default:
+            break;
     }
 }
 
@@ -280,6 +349,7 @@ void activateAckLed() {
 }
 
 void updateAckLed() {
+    PROFILE_ZONE("updateAckLed");
     if (ackLedActive && (millis() - ackLedStartTime > ACK_LED_DURATION)) {
         digitalWrite(ACK_LED_PIN, LOW);
         ackLedActive = false;
@@ -288,6 +358,7 @@ void updateAckLed() {
 }
 
 void handleDisconnection() {
+    PROFILE_ZONE("handleDisconnection");
     static unsigned long lastReconnectAttempt = 0;
     
     // Elke 5 seconden opnieuw proberen
@@ -298,8 +369,10 @@ void handleDisconnection() {
         digitalWrite(SENDER_LED_PIN, LOW);            // LED uit bij verbindingsproblemen
         digitalWrite(ACK_LED_PIN, LOW);               // Bevestigings LED uit
         
-        waitingForAck = false;
+        doorbellLink.cancelAck();
+        power.releaseRadio();
         ackLedActive = false;
+        ringFlashActive = false;
         
         WiFi.disconnect();
         WiFi.reconnect();
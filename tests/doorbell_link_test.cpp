@@ -0,0 +1,132 @@
+/**
+ * ESP32 Remote Deurbel - Host test RING/QSL protocol
+ * ============================================
+ *
+ * Draait hetzelfde RING -> QSL scenario via DoorbellLink over de
+ * loopback- en de UDP-backend (localhost) en toont per backend de
+ * gemeten RING-naar-QSL latentie. Controleert daarnaast dat herhaalde
+ * RINGs en dubbele of te late QSLs geen extra events opleveren.
+ * Tijden zijn in microseconden.
+ */
+
+#include "doorbell_link.h"
+
+#include <stdio.h>
+#include <chrono>
+
+const int ROUNDS = 100;
+const unsigned long ACK_TIMEOUT_US = 2000000;
+const unsigned long RING_INTERVAL_US = DOORBELL_RING_INTERVAL * 1000;
+const unsigned long DUPLICATE_WINDOW_US = 5000;             // Kort, zodat rondes snel na elkaar kunnen
+
+static bool check(bool condition, const char* description) {
+    if (!condition) printf("FOUT: %s\n", description);
+    return condition;
+}
+
+static unsigned long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Eén backend: ROUNDS keer RING versturen, wachten op QSL, latentie bijhouden
+static bool runScenario(DoorbellTransport& senderTransport, DoorbellTransport& receiverTransport) {
+    DoorbellLink sender(senderTransport, ACK_TIMEOUT_US, RING_INTERVAL_US, DUPLICATE_WINDOW_US);
+    DoorbellLink receiver(receiverTransport, ACK_TIMEOUT_US, RING_INTERVAL_US, DUPLICATE_WINDOW_US);
+
+    if (!sender.begin() || !receiver.begin()) {
+        printf("%-8s FOUT: transport niet gestart\n", senderTransport.name());
+        return false;
+    }
+
+    unsigned long latencyMin = 0, latencyMax = 0, latencySum = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        sender.sendRing(nowUs());
+
+        bool rang = false;
+        DoorbellEvent event = DOORBELL_NONE;
+        while (event != DOORBELL_ACK && event != DOORBELL_ACK_TIMEOUT) {
+            if (receiver.poll(nowUs()) == DOORBELL_RING) rang = true;
+            event = sender.poll(nowUs());
+        }
+
+        if (!rang || event != DOORBELL_ACK) {
+            printf("%-8s FOUT in ronde %d: %s\n", senderTransport.name(), round,
+                   rang ? "geen QSL ontvangen" : "geen RING ontvangen");
+            return false;
+        }
+
+        // Overgebleven frames afhandelen en buiten het duplicate-venster komen
+        unsigned long drainStart = nowUs();
+        while (nowUs() - drainStart < DUPLICATE_WINDOW_US + 1000) {
+            receiver.poll(nowUs());
+            sender.poll(nowUs());
+        }
+
+        unsigned long latency = sender.lastAckLatency();
+        if (round == 0 || latency < latencyMin) latencyMin = latency;
+        if (latency > latencyMax) latencyMax = latency;
+        latencySum += latency;
+    }
+
+    printf("%-8s RING-naar-QSL: min %6lu / gem %6lu / max %6lu us (%d rondes)\n",
+           senderTransport.name(), latencyMin, latencySum / ROUNDS, latencyMax, ROUNDS);
+    return true;
+}
+
+// Herhaalde RINGs, dubbele QSLs en een QSL na de timeout via een kale loopback-peer
+static bool runDuplicateChecks() {
+    LoopbackTransport raw, linked;
+    raw.connect(linked);
+    DoorbellLink link(linked, 100, 10, 1000);
+    char buffer[DOORBELL_MAX_FRAME];
+    bool ok = true;
+
+    // Ontvanger: drie RINGs geven één DOORBELL_RING, maar wel drie keer QSL
+    for (int i = 0; i < 3; i++) raw.sendFrame(DOORBELL_RING_PAYLOAD);
+    ok &= check(link.poll(0) == DOORBELL_RING, "eerste RING wordt gemeld");
+    ok &= check(link.poll(10) == DOORBELL_NONE, "tweede RING is een herhaling");
+    ok &= check(link.poll(20) == DOORBELL_NONE, "derde RING is een herhaling");
+    int acks = 0;
+    while (raw.pollFrame(buffer, sizeof(buffer)) > 0) acks++;
+    ok &= check(acks == 3, "elke RING krijgt QSL");
+
+    // Na het venster is een RING weer een nieuwe deurbel
+    raw.sendFrame(DOORBELL_RING_PAYLOAD);
+    ok &= check(link.poll(2000) == DOORBELL_RING, "RING na het venster wordt gemeld");
+    while (raw.pollFrame(buffer, sizeof(buffer)) > 0) {}
+
+    // Zender: alleen de eerste QSL telt
+    link.sendRing(3000);
+    raw.sendFrame(DOORBELL_ACK_PAYLOAD);
+    raw.sendFrame(DOORBELL_ACK_PAYLOAD);
+    ok &= check(link.poll(3005) == DOORBELL_ACK, "eerste QSL wordt gemeld");
+    ok &= check(link.lastAckLatency() == 5, "latentie van deze RING");
+    ok &= check(link.poll(3006) == DOORBELL_NONE, "dubbele QSL wordt genegeerd");
+    ok &= check(link.lastAckLatency() == 5, "latentie blijft staan");
+
+    // Zender: QSL na de timeout telt niet
+    link.sendRing(4000);
+    while (raw.pollFrame(buffer, sizeof(buffer)) > 0) {}
+    ok &= check(link.poll(4200) == DOORBELL_ACK_TIMEOUT, "timeout wordt gemeld");
+    raw.sendFrame(DOORBELL_ACK_PAYLOAD);
+    ok &= check(link.poll(4300) == DOORBELL_NONE, "te late QSL wordt genegeerd");
+
+    printf("Duplicaten: %s\n", ok ? "OK" : "FOUT");
+    return ok;
+}
+
+int main() {
+    bool ok = runDuplicateChecks();
+
+    LoopbackTransport loopSender, loopReceiver;
+    loopSender.connect(loopReceiver);
+    ok &= runScenario(loopSender, loopReceiver);
+
+    UdpTransport udpSender("127.0.0.1", 42102, 42101);
+    UdpTransport udpReceiver("127.0.0.1", 42101, 42102);
+    ok &= runScenario(udpSender, udpReceiver);
+
+    return ok ? 0 : 1;
+}